@@ -7,19 +7,30 @@ in vec3 FragPos_World;        // Pozycja fragmentu w przestrzeni świata
 in vec3 Normal_World;         // Wektor normalny fragmentu w przestrzeni świata (znormalizowany przez VS)
 in vec2 TexCoords;            // Współrzędne tekstury
 in vec4 VertexColor_FS;       // Kolor wierzchołka (może być używany lub nie)
-in vec4 FragPosDirLightSpace; // Pozycja fragmentu w przestrzeni światła kierunkowego
-
-// Pozycja fragmentu w przestrzeniach świateł reflektorów rzucających cień
-// Rozmiar tablicy musi być zsynchronizowany z VS i C++
-const int MAX_SHADOW_CASTING_SPOT_LIGHTS_FS_CONST = 2; // Używamy stałej dla rozmiaru tablicy
-in vec4 FragPosSpotLightSpace[MAX_SHADOW_CASTING_SPOT_LIGHTS_FS_CONST];
-
-
-// --- Stałe definiujące maksymalne liczby świateł (muszą być zsynchronizowane z C++) ---
-const int MAX_POINT_LIGHTS_FS = 4;              // Maksymalna liczba świateł punktowych
-const int MAX_SPOT_LIGHTS_TOTAL_FS = 4;         // Maksymalna łączna liczba reflektorów (aktywnych i nieaktywnych w tablicy)
-const int MAX_SHADOW_CASTING_SPOT_LIGHTS_FS = 2;// Maksymalna liczba reflektorów rzucających cień
-const int MAX_SHADOW_CASTING_POINT_LIGHTS_FS = 1;// Maksymalna liczba świateł punktowych rzucających cień
+in vec4 InstanceTint_FS;      // Mnożnik koloru materiału instancji (vec4(1.0) dla zwykłych obiektów)
+flat in int MaterialIndex_FS; // Indeks materiału w MaterialBlock (-1 = użyj uniformu 'material'), wybierany w VS
+
+// --- Stałe (muszą być zsynchronizowane z C++) ---
+const int SHADOW_VIEW_TEXELS_FS = 5;            // Teksele na widok w u_shadowViews (SHADOW_VIEW_TEXELS w ShadowAtlas.h)
+const int MAX_SHADOW_CASCADES_FS = 4;           // Maksymalna liczba kaskad cienia światła kierunkowego (MAX_SHADOW_CASCADES w C++)
+const int MAX_POISSON_TAPS_FS = 16;             // Maksymalna liczba próbek jądra Poissona (MAX_POISSON_TAPS w C++)
+
+// --- Permutacje shadera ---
+// Wariant (ResourceManager::getShaderVariant) dostaje po #version definicje z ShaderVariantKey::buildDefines().
+// Cechy są wtedy stałymi kompilacji i kompilator usuwa nieużywane gałęzie (próbkowanie tekstur, pętle PCF).
+// Bez definicji (shader bazowy) te same cechy są wybierane w czasie działania przez uniformy.
+#ifdef PGK_VARIANT
+    #define USE_DIFFUSE_TEXTURE (HAS_DIFFUSE_TEX != 0)
+    #define USE_SPECULAR_TEXTURE (HAS_SPECULAR_TEX != 0)
+    #define USE_FLAT_SHADING (FLAT_SHADING != 0)
+    #define SHADOW_CASCADE_LIMIT NUM_CASCADES
+#else
+    #define USE_DIFFUSE_TEXTURE material.useDiffuseTexture
+    #define USE_SPECULAR_TEXTURE material.useSpecularTexture
+    #define USE_FLAT_SHADING u_useFlatShading
+    #define SHADOWS_PCF 1
+    #define SHADOW_CASCADE_LIMIT 4 // MAX_SHADOW_CASCADES_FS (stała nie jest widoczna w #if)
+#endif
 
 // --- Struktura Materiału ---
 struct Material {
@@ -36,165 +47,389 @@ struct Material {
 };
 
 // --- Struktury Świateł ---
+// Uwaga: DirectionalLight i ClusterGrid są częścią bloku LightingBlock (std140) i muszą
+// odpowiadać strukturom *Std140 w LightingUBO.h i ClusteredLighting.h. Reflektory i światła
+// punktowe są odczytywane z bufora tekstury u_clusterLights (FetchSpotLight / FetchPointLight).
 struct DirectionalLight {
     vec3 direction;   // Kierunek padania światła (od źródła)
+    bool enabled;     // Czy światło jest włączone
     vec3 ambient;     // Składowa ambient światła
     vec3 diffuse;     // Składowa diffuse światła
     vec3 specular;    // Składowa specular światła
-    bool enabled;     // Czy światło jest włączone
-};
-
-// Dane potrzebne do obliczania cieni dla reflektora
-struct SpotLightShadowData {
-    sampler2D shadowMap; // Tekstura mapy cieni (2D)
-    bool enabled;        // Czy cienie dla tego slotu są włączone
-    float texelSize;     // Rozmiar teksela mapy cieni (1.0 / szerokosc_mapy_cieni)
 };
 
 // Reflektor (Spot Light)
 struct SpotLight {
     vec3 position;    // Pozycja źródła światła
-    vec3 direction;   // Kierunek świecenia
     float cutOff;     // Cosinus wewnętrznego kąta stożka (pełna intensywność)
+    vec3 direction;   // Kierunek świecenia
     float outerCutOff;// Cosinus zewnętrznego kąta stożka (stopniowe zanikanie)
 
-    // Współczynniki tłumienia (attenuation)
+    // Składowe koloru przeplecione ze współczynnikami tłumienia (attenuation)
+    vec3 ambient;
     float constant;
+    vec3 diffuse;
     float linear;
+    vec3 specular;
     float quadratic;
 
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
     bool enabled;
 
     // Dane związane z cieniami
     bool castsShadow;        // Czy ten reflektor rzuca cień
-    int shadowDataIndex;     // Indeks do tablicy spotLightShadowData (jeśli castsShadow = true)
-                             // Wartość -1 może oznaczać brak przypisanej mapy cieni.
-};
-
-// Dane potrzebne do obliczania cieni dla światła punktowego
-struct PointLightShadowData {
-    samplerCube shadowCubeMap; // Tekstura mapy cieni (Cube Map)
-    float farPlane;            // Daleka płaszczyzna przycinania użyta do generowania mapy cieni
-    bool enabled;              // Czy cienie dla tego slotu są włączone
+    int shadowDataIndex;     // Indeks widoku w u_shadowViews (jeśli castsShadow = true)
+                             // Wartość -1 oznacza brak kafelka w atlasie cieni.
 };
 
 // Światło punktowe (Point Light)
 struct PointLight {
     vec3 position;
-
     float constant;
-    float linear;
-    float quadratic;
-
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
     bool enabled;
 
     bool castsShadow;
-    int shadowDataIndex; // Indeks do tablicy pointLightShadowData
+    int shadowDataIndex; // Pierwszy z sześciu widoków (ściany +X, -X, +Y, -Y, +Z, -Z) w u_shadowViews
+};
+
+// Parametry siatki klastrów (froxeli) ostrosłupa kamery
+struct ClusterGrid {
+    ivec4 dimensions;  // Liczba klastrów w X, Y, Z; w = liczba świateł w u_clusterLights
+    vec4 depthParams;  // x = skala, y = przesunięcie plasterka (slice = log(głębokość) * x + y), z = near, w = far
+    vec4 screenParams; // x, y = kafelki na piksel
+};
+
+// --- Blok danych oświetlenia (UBO) ---
+// Wspólny dla wszystkich shaderów, aktualizowany raz na klatkę przez LightingManager.
+// Punkt wiązania nadawany jest z C++ (LIGHTING_UBO_BINDING_POINT w UniformBlocks.h).
+layout (std140) uniform LightingBlock {
+    DirectionalLight dirLight;
+    ClusterGrid clusterGrid;
+};
+
+// --- Oświetlenie klastrowe (ClusteredLighting.cpp) ---
+// Listy świateł klastrów budowane są na CPU raz na klatkę. Jednostki tekstur ustawiane są z C++
+// (CLUSTER_LIGHT_TEXTURE_UNIT i CLUSTER_INDEX_TEXTURE_UNIT w UniformBlocks.h).
+const int CLUSTER_LIGHT_TEXELS_FS = 6; // CLUSTER_LIGHT_TEXELS w C++
+uniform samplerBuffer u_clusterLights; // Dane świateł: najpierw reflektory, potem punktowe (6 tekseli RGBA32F na światło)
+uniform usamplerBuffer u_clusterItems; // Pary (początek, liczba) dla każdego klastra, a za nimi indeksy świateł
+
+// --- Blok stałych klatki (UBO) ---
+// Deklaracja musi być identyczna jak w default_shader.vert.
+// Punkt wiązania nadawany jest z C++ (FRAME_UBO_BINDING_POINT w UniformBlocks.h).
+layout (std140) uniform FrameConstants {
+    mat4 view;               // Macierz widoku kamery
+    mat4 projection;         // Macierz projekcji kamery
+    mat4 viewProjection;     // projection * view
+    vec3 cameraPosition;     // Pozycja kamery (obserwatora) w przestrzeni świata
+    float time;              // Czas od uruchomienia aplikacji (sekundy)
+};
+
+// --- Blok materiałów (UBO) ---
+// Odpowiada MaterialStd140 w MaterialSystem.h; rozmiar tablicy = MAX_MATERIALS w UniformBlocks.h.
+// Punkt wiązania nadawany jest z C++ (MATERIAL_UBO_BINDING_POINT w UniformBlocks.h).
+const int MAX_MATERIALS_FS = 256;
+const int MAX_MATERIAL_PAGES_FS = 4; // MAX_MATERIAL_PAGES w C++
+struct MaterialEntry {
+    vec4 ambientShininess; // rgb = ambient, a = połysk
+    vec4 diffuse;          // rgb = diffuse
+    vec4 specular;         // rgb = specular
+    ivec4 textures;        // Strona i warstwa tekstury diffuse (x, y) oraz specular (z, w); -1 = brak
 };
+layout (std140) uniform MaterialBlock {
+    MaterialEntry materials[MAX_MATERIALS_FS];
+};
+uniform sampler2DArray u_materialPages[MAX_MATERIAL_PAGES_FS]; // Strony tekstur materiałów (jednostki ustawiane z C++)
 
 // --- Uniformy ---
 uniform Material material;         // Materiał aktualnie renderowanego obiektu
-uniform vec3 viewPos_World;        // Pozycja kamery (obserwatora) w przestrzeni świata
-uniform bool u_UseFlatShading;     // Flaga: czy używać płaskiego cieniowania (tylko kolor diffuse, bez oświetlenia)
+uniform bool u_useFlatShading;     // Flaga: czy używać płaskiego cieniowania (tylko kolor diffuse, bez oświetlenia)
 
-// Światło kierunkowe i jego cień
-uniform DirectionalLight dirLight;
-uniform sampler2D dirShadowMap;        // Mapa cieni dla światła kierunkowego
+// Cień światła kierunkowego (Cascaded Shadow Maps)
+uniform sampler2DArrayShadow dirShadowMap; // Kaskady mapy cieni światła kierunkowego (jedna warstwa na kaskadę, porównanie sprzętowe)
+uniform mat4 dirCascadeMatrices[MAX_SHADOW_CASCADES_FS]; // Macierze przestrzeni światła dla kaskad
+uniform float dirCascadeSplits[MAX_SHADOW_CASCADES_FS];  // Dalekie granice kaskad (głębokość w przestrzeni widoku)
+uniform int dirCascadeCount;         // Liczba aktywnych kaskad (0 = brak cienia kierunkowego)
 uniform float shadowMapTexelSize;  // Rozmiar teksela dla dirShadowMap (1.0 / szerokosc_mapy)
-uniform int u_pcfRadius;           // Promień dla PCF (Percentage Closer Filtering)
+uniform int u_pcfRadius;           // Promień dla PCF (Percentage Closer Filtering) w tekselach
+uniform int u_pcfKernel;           // Rozkład próbek PCF: 0 = siatka (2r+1)^2, 1 = dysk Poissona (PCFKernel w C++)
+uniform int u_poissonTaps;         // Liczba próbek dysku Poissona (1..MAX_POISSON_TAPS_FS)
+
+// Dysk Poissona w kole jednostkowym. Pierwsze próbki są rozłożone równomiernie,
+// więc mniejsza liczba próbek nadal pokrywa całe koło.
+const vec2 POISSON_DISK[MAX_POISSON_TAPS_FS] = vec2[](
+    vec2(-0.94201624, -0.39906216), vec2( 0.94558609, -0.76890725),
+    vec2(-0.09418410, -0.92938870), vec2( 0.34495938,  0.29387760),
+    vec2(-0.91588581,  0.45771432), vec2(-0.81544232, -0.87912464),
+    vec2(-0.38277543,  0.27676845), vec2( 0.97484398,  0.75648379),
+    vec2( 0.44323325, -0.97511554), vec2( 0.53742981, -0.47373420),
+    vec2(-0.26496911, -0.41893023), vec2( 0.79197514,  0.19090188),
+    vec2(-0.24188840,  0.99706507), vec2(-0.81409955,  0.91437590),
+    vec2( 0.19984126,  0.78641367), vec2( 0.14383161, -0.14100790)
+);
+
+// Cienie reflektorów i świateł punktowych - jeden atlas, kafelki opisane w buforze widoków
+uniform sampler2DShadow u_shadowAtlas;  // Atlas map cieni z porównaniem sprzętowym
+uniform samplerBuffer u_shadowViews;    // Widoki: 4 kolumny macierzy światła + prostokąt kafelka (offset.xy, skala.zw) w UV
+uniform float u_shadowAtlasTexelSize;   // Rozmiar teksela atlasu (1.0 / bok_atlasu)
 
-// Reflektory i ich dane cieni
-uniform SpotLight spotLights[MAX_SPOT_LIGHTS_TOTAL_FS]; // Tablica wszystkich reflektorów
-uniform int numSpotLights;                              // Liczba aktywnych reflektorów w tablicy spotLights
-uniform SpotLightShadowData spotLightShadowData[MAX_SHADOW_CASTING_SPOT_LIGHTS_FS]; // Dane map cieni dla reflektorów
+// --- Funkcje Pomocnicze ---
 
-// Światła punktowe i ich dane cieni
-uniform PointLight pointLights[MAX_POINT_LIGHTS_FS];    // Tablica wszystkich świateł punktowych
-uniform int numPointLights;                             // Liczba aktywnych świateł punktowych
-uniform PointLightShadowData pointLightShadowData[MAX_SHADOW_CASTING_POINT_LIGHTS_FS]; // Dane map cieni dla świateł punktowych
+/**
+ * Wyznacza klaster fragmentu: kafelek ekranu z gl_FragCoord i wykładniczy plasterek z głębokości w przestrzeni widoku.
+ * @param fragPos_World Pozycja fragmentu w przestrzeni świata.
+ * @return Indeks klastra (z * Y + y) * X + x.
+ */
+int ComputeClusterIndex(vec3 fragPos_World) {
+    float viewDepth = max(-(view * vec4(fragPos_World, 1.0)).z, 1e-6);
+    int slice = int(floor(log(viewDepth) * clusterGrid.depthParams.x + clusterGrid.depthParams.y));
+    ivec2 tile = ivec2(gl_FragCoord.xy * clusterGrid.screenParams.xy);
+    ivec3 cell = clamp(ivec3(tile, slice), ivec3(0), clusterGrid.dimensions.xyz - ivec3(1));
+    return (cell.z * clusterGrid.dimensions.y + cell.y) * clusterGrid.dimensions.x + cell.x;
+}
 
-// --- Funkcje Pomocnicze ---
+/**
+ * Odczytuje reflektor z bufora świateł (układ tekseli jak w ClusteredLighting::packLights).
+ * @param base Indeks pierwszego teksela światła.
+ */
+SpotLight FetchSpotLight(int base) {
+    vec4 t0 = texelFetch(u_clusterLights, base);
+    vec4 t1 = texelFetch(u_clusterLights, base + 1);
+    vec4 t2 = texelFetch(u_clusterLights, base + 2);
+    vec4 t3 = texelFetch(u_clusterLights, base + 3);
+    vec4 t4 = texelFetch(u_clusterLights, base + 4);
+    vec4 t5 = texelFetch(u_clusterLights, base + 5);
+    SpotLight light;
+    light.position = t0.xyz;
+    light.ambient = t1.rgb;   light.constant = t1.w;
+    light.diffuse = t2.rgb;   light.linear = t2.w;
+    light.specular = t3.rgb;  light.quadratic = t3.w;
+    light.direction = t4.xyz;
+    light.cutOff = t5.x;
+    light.outerCutOff = t5.y;
+    light.enabled = true;     // Wyłączone światła nie trafiają do bufora
+    light.shadowDataIndex = int(t4.w);
+    light.castsShadow = light.shadowDataIndex >= 0;
+    return light;
+}
+
+/**
+ * Odczytuje światło punktowe z bufora świateł.
+ * @param base Indeks pierwszego teksela światła.
+ */
+PointLight FetchPointLight(int base) {
+    vec4 t0 = texelFetch(u_clusterLights, base);
+    vec4 t1 = texelFetch(u_clusterLights, base + 1);
+    vec4 t2 = texelFetch(u_clusterLights, base + 2);
+    vec4 t3 = texelFetch(u_clusterLights, base + 3);
+    vec4 t4 = texelFetch(u_clusterLights, base + 4);
+    PointLight light;
+    light.position = t0.xyz;
+    light.ambient = t1.rgb;   light.constant = t1.w;
+    light.diffuse = t2.rgb;   light.linear = t2.w;
+    light.specular = t3.rgb;  light.quadratic = t3.w;
+    light.enabled = true;
+    light.shadowDataIndex = int(t4.w);
+    light.castsShadow = light.shadowDataIndex >= 0;
+    return light;
+}
 
 /**
- * Oblicza współczynnik cienia dla map 2D (światło kierunkowe, reflektory)
+ * Próbkuje teksturę ze strony materiałów.
+ * GLSL 3.30 nie pozwala indeksować tablicy samplerów wyrażeniem niestałym, stąd wybór strony przez warunki.
+ * @param page Indeks strony (0..MAX_MATERIAL_PAGES_FS-1).
+ * @param layer Warstwa w stronie.
+ * @param uv Współrzędne tekstury.
+ */
+vec4 SampleMaterialPage(int page, int layer, vec2 uv) {
+    vec3 coords = vec3(uv, float(layer));
+    if (page == 0) return texture(u_materialPages[0], coords);
+    if (page == 1) return texture(u_materialPages[1], coords);
+    if (page == 2) return texture(u_materialPages[2], coords);
+    return texture(u_materialPages[3], coords);
+}
+
+/**
+ * Obrót dysku Poissona dla bieżącego piksela (interleaved gradient noise).
+ * Zamienia pasmowanie wynikające z małej liczby próbek na drobny, stały w czasie szum.
+ */
+mat2 PoissonRotation() {
+    float angle = 6.28318531 * fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+    float s = sin(angle);
+    float c = cos(angle);
+    return mat2(c, s, -s, c);
+}
+
+/**
+ * Filtruje kafelek atlasu cieni jądrem wybranym przez u_pcfKernel.
+ * Każde wywołanie texture() na sampler2DShadow zwraca już uśrednione porównanie 2x2 teksli.
+ * Próbki są przycinane do kafelka (z marginesem pół teksela), aby nie czytać sąsiednich map.
+ * @param uv Współrzędne środka jądra w atlasie.
+ * @param refDepth Głębokość fragmentu pomniejszona o bias (porównanie GL_LEQUAL).
+ * @param bounds Granice kafelka w UV atlasu (min.xy, max.zw).
+ * @return Współczynnik cienia (0.0 - brak cienia, 1.0 - pełny cień).
+ */
+float FilterShadowAtlas(vec2 uv, float refDepth, vec4 bounds) {
+    float texelSize = u_shadowAtlasTexelSize;
+    float lit = 0.0;
+    if (u_pcfKernel == 1) {
+        int taps = clamp(u_poissonTaps, 1, MAX_POISSON_TAPS_FS);
+        mat2 rotation = PoissonRotation();
+        float radius = max(float(u_pcfRadius), 1.0) * texelSize;
+        for (int i = 0; i < taps; ++i) {
+            vec2 tap = clamp(uv + rotation * POISSON_DISK[i] * radius, bounds.xy, bounds.zw);
+            lit += texture(u_shadowAtlas, vec3(tap, refDepth));
+        }
+        return 1.0 - lit / float(taps);
+    }
+    float totalSamples = 0.0;
+    for (int x = -u_pcfRadius; x <= u_pcfRadius; ++x) {
+        for (int y = -u_pcfRadius; y <= u_pcfRadius; ++y) {
+            vec2 tap = clamp(uv + vec2(x, y) * texelSize, bounds.xy, bounds.zw);
+            lit += texture(u_shadowAtlas, vec3(tap, refDepth));
+            totalSamples += 1.0;
+        }
+    }
+    return 1.0 - lit / totalSamples;
+}
+
+/**
+ * Odpowiednik FilterShadowAtlas dla warstwy tablicy map cieni (kaskady światła kierunkowego).
+ */
+float FilterShadow2DArray(sampler2DArrayShadow shadowMap, vec2 uv, float layer, float refDepth, float texelSize) {
+    float lit = 0.0;
+    if (u_pcfKernel == 1) {
+        int taps = clamp(u_poissonTaps, 1, MAX_POISSON_TAPS_FS);
+        mat2 rotation = PoissonRotation();
+        float radius = max(float(u_pcfRadius), 1.0) * texelSize;
+        for (int i = 0; i < taps; ++i) {
+            lit += texture(shadowMap, vec4(uv + rotation * POISSON_DISK[i] * radius, layer, refDepth));
+        }
+        return 1.0 - lit / float(taps);
+    }
+    float totalSamples = 0.0;
+    for (int x = -u_pcfRadius; x <= u_pcfRadius; ++x) {
+        for (int y = -u_pcfRadius; y <= u_pcfRadius; ++y) {
+            lit += texture(shadowMap, vec4(uv + vec2(x, y) * texelSize, layer, refDepth));
+            totalSamples += 1.0;
+        }
+    }
+    return 1.0 - lit / totalSamples;
+}
+
+/**
+ * Oblicza współczynnik cienia z jednego widoku atlasu (reflektor lub ściana światła punktowego)
  * używając Percentage Closer Filtering (PCF) dla zmiękczenia krawędzi cieni.
- * @param fragPosLightSpace Pozycja fragmentu w przestrzeni światła.
- * @param specificShadowMap Tekstura mapy cieni do próbkowania.
- * @param specificTexelSize Rozmiar teksela danej mapy cieni.
+ * @param viewIndex Indeks widoku w u_shadowViews.
+ * @param fragPos_World Pozycja fragmentu w przestrzeni świata.
  * @param normalWorld Normalna fragmentu w przestrzeni świata.
  * @param lightDirWorld Kierunek od fragmentu do źródła światła w przestrzeni świata.
- * @return Współczynnik cienia (0.0 - w cieniu, 1.0 - w pełni oświetlony).
- * W shaderze jest odwrotnie: 0.0 - brak cienia, 1.0 - pełny cień. Zostawiam jak w oryginale.
+ * @return Współczynnik cienia (0.0 - brak cienia, 1.0 - pełny cień).
  */
-float CalculateShadowFactorPCF_2D(vec4 fragPosLightSpace, sampler2D specificShadowMap, float specificTexelSize, vec3 normalWorld, vec3 lightDirWorld) {
+float CalculateAtlasShadowFactor(int viewIndex, vec3 fragPos_World, vec3 normalWorld, vec3 lightDirWorld) {
+    int base = viewIndex * SHADOW_VIEW_TEXELS_FS;
+    mat4 lightSpaceMatrix = mat4(texelFetch(u_shadowViews, base),
+                                 texelFetch(u_shadowViews, base + 1),
+                                 texelFetch(u_shadowViews, base + 2),
+                                 texelFetch(u_shadowViews, base + 3));
+    vec4 tileRect = texelFetch(u_shadowViews, base + 4);
+
     // Transformacja współrzędnych do przestrzeni tekstury mapy cieni [0,1] i normalizacja przez w
+    vec4 fragPosLightSpace = lightSpaceMatrix * vec4(fragPos_World, 1.0);
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     projCoords = projCoords * 0.5 + 0.5; // Przekształcenie z [-1,1] do [0,1]
 
-    float currentDepth = projCoords.z; // Głębokość bieżącego fragmentu z perspektywy światła
-
     // Sprawdzenie, czy fragment znajduje się poza obszarem mapy cieni lub za daleką płaszczyzną
     if (projCoords.z > 1.0 || projCoords.x < 0.0 || projCoords.x > 1.0 || projCoords.y < 0.0 || projCoords.y > 1.0) {
-        return 0.0; // Poza mapą cieni, brak cienia (lub pełne światło, zależy od interpretacji)
+        return 0.0;
     }
 
-    float shadow = 0.0; // Akumulator współczynnika cienia
-    // Bias zapobiegający "shadow acne" (artefakty samocieniowania)
-    // Dynamiczny bias zależny od kąta padania światła
+    // Przejście z UV kafelka do UV atlasu
+    vec2 halfTexel = vec2(0.5 * u_shadowAtlasTexelSize);
+    vec4 bounds = vec4(tileRect.xy + halfTexel, tileRect.xy + tileRect.zw - halfTexel);
+    vec2 atlasUV = tileRect.xy + projCoords.xy * tileRect.zw;
+
+    // Bias zapobiegający "shadow acne" (artefakty samocieniowania), zależny od kąta padania światła
     float bias = max(0.005 * (1.0 - dot(normalWorld, lightDirWorld)), 0.0005);
-    float totalSamples = 0.0;
 
-    // Pętla PCF - próbkowanie wokół centralnego punktu w mapie cieni
-    for (int x = -u_pcfRadius; x <= u_pcfRadius; ++x) {
-        for (int y = -u_pcfRadius; y <= u_pcfRadius; ++y) {
-            vec2 offset = vec2(x, y) * specificTexelSize; // Przesunięcie próbki
-            // Głębokość zapisana w mapie cieni dla przesuniętej próbki
-            float pcfDepth = texture(specificShadowMap, projCoords.xy + offset).r;
-            // Porównanie głębokości bieżącego fragmentu z głębokością z mapy cieni
-            if (currentDepth - bias > pcfDepth) {
-                shadow += 1.0; // Fragment jest w cieniu tej próbki
-            }
-            totalSamples += 1.0;
+    // Porównanie głębokości wykonuje sprzęt - fragment jest oświetlony, gdy (głębokość - bias) <= głębokość z mapy
+    return FilterShadowAtlas(atlasUV, projCoords.z - bias, bounds);
+}
+
+/**
+ * Oblicza współczynnik cienia światła kierunkowego z kaskadowych map cieni.
+ * Kaskada wybierana jest na podstawie głębokości fragmentu w przestrzeni widoku kamery.
+ * @param fragPos_World Pozycja fragmentu w przestrzeni świata.
+ * @param normalWorld Normalna fragmentu w przestrzeni świata.
+ * @param lightDirWorld Kierunek od fragmentu do źródła światła w przestrzeni świata.
+ * @return Współczynnik cienia (0.0 - brak cienia, 1.0 - pełny cień).
+ */
+float CalculateDirShadowFactorCSM(vec3 fragPos_World, vec3 normalWorld, vec3 lightDirWorld) {
+#if SHADOWS_PCF && SHADOW_CASCADE_LIMIT > 0
+    // Wariant zna liczbę kaskad w czasie kompilacji - pętla wyboru kaskady ma stałą długość
+    int cascadeCount = min(dirCascadeCount, SHADOW_CASCADE_LIMIT);
+    if (cascadeCount <= 0) {
+        return 0.0;
+    }
+
+    float viewDepth = -(view * vec4(fragPos_World, 1.0)).z;
+    if (viewDepth > dirCascadeSplits[cascadeCount - 1]) {
+        return 0.0; // Poza zasięgiem ostatniej kaskady
+    }
+    int cascade = cascadeCount - 1;
+    for (int i = 0; i < SHADOW_CASCADE_LIMIT; ++i) {
+        if (i >= cascadeCount) {
+            break;
+        }
+        if (viewDepth <= dirCascadeSplits[i]) {
+            cascade = i;
+            break;
         }
     }
-    if (totalSamples > 0.0) shadow /= totalSamples; // Uśrednienie wyniku
-    return shadow; // 0.0 = brak cienia, 1.0 = pełny cień (w tej implementacji)
+
+    vec4 fragPosLightSpace = dirCascadeMatrices[cascade] * vec4(fragPos_World, 1.0);
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+    projCoords = projCoords * 0.5 + 0.5;
+    float currentDepth = projCoords.z;
+    if (projCoords.z > 1.0 || projCoords.x < 0.0 || projCoords.x > 1.0 || projCoords.y < 0.0 || projCoords.y > 1.0) {
+        return 0.0;
+    }
+
+    // Dalsze kaskady pokrywają większy obszar na teksel, więc potrzebują nieco większego biasu
+    float bias = max(0.005 * (1.0 - dot(normalWorld, lightDirWorld)), 0.0005) * (1.0 + float(cascade));
+    return FilterShadow2DArray(dirShadowMap, projCoords.xy, float(cascade), currentDepth - bias, shadowMapTexelSize);
+#else
+    return 0.0; // Wariant bez cieni
+#endif
 }
 
 /**
- * Oblicza współczynnik cienia dla światła punktowego (używając CubeMap).
+ * Oblicza współczynnik cienia dla światła punktowego - ściana wybierana jest
+ * przez dominującą oś wektora od światła do fragmentu (kolejność ścian jak w C++).
  * @param fragPos_World Pozycja fragmentu w przestrzeni świata.
  * @param currentPointLight Aktualnie przetwarzane światło punktowe.
- * @param shadowData Dane mapy cieni dla tego światła.
+ * @param normalWorld Normalna fragmentu w przestrzeni świata.
+ * @param lightDirWorld Kierunek od fragmentu do źródła światła.
  * @return Współczynnik cienia (0.0 - brak cienia, 1.0 - pełny cień).
  */
-float CalculatePointShadowFactor(vec3 fragPos_World, PointLight currentPointLight, PointLightShadowData shadowData) {
-    // Wektor od źródła światła do fragmentu (używany do próbkowania CubeMap)
-    vec3 fragToLightVector = fragPos_World - currentPointLight.position;
-    // Aktualna głębokość fragmentu (odległość liniowa od źródła światła)
-    float currentDepthLinear = length(fragToLightVector);
-
-    // Odczyt najbliższej zapisanej głębokości z CubeMap
-    // CubeMap przechowuje wartości znormalizowane [0,1], więc trzeba je przeskalować
-    float closestDepthNormalized = texture(shadowData.shadowCubeMap, fragToLightVector).r;
-    float closestDepthLinear = closestDepthNormalized * shadowData.farPlane; // Przeskalowanie do odległości liniowej
-
-    float shadow = 0.0;
-    float bias = 0.05; // Bias dla cieni punktowych (może wymagać dostosowania)
-    // Porównanie głębokości
-    if (currentDepthLinear - bias > closestDepthLinear) {
-        shadow = 1.0; // Fragment jest w cieniu
+float CalculatePointShadowFactor(vec3 fragPos_World, PointLight currentPointLight, vec3 normalWorld, vec3 lightDirWorld) {
+    vec3 lightToFrag = fragPos_World - currentPointLight.position;
+    vec3 absDir = abs(lightToFrag);
+    int face;
+    if (absDir.x >= absDir.y && absDir.x >= absDir.z) {
+        face = lightToFrag.x >= 0.0 ? 0 : 1; // +X / -X
+    } else if (absDir.y >= absDir.z) {
+        face = lightToFrag.y >= 0.0 ? 2 : 3; // +Y / -Y
+    } else {
+        face = lightToFrag.z >= 0.0 ? 4 : 5; // +Z / -Z
     }
-    return shadow;
+    return CalculateAtlasShadowFactor(currentPointLight.shadowDataIndex + face, fragPos_World, normalWorld, lightDirWorld);
 }
 
-
 // --- Funkcje obliczające wkład poszczególnych typów świateł ---
 // Przyjmują teraz efektywne właściwości materiału jako argumenty.
 
@@ -205,7 +440,7 @@ vec3 CalculateDirLightContribution(DirectionalLight light, vec3 normal, vec3 vie
     vec3 lightDirToSource = normalize(-light.direction); // Kierunek DO źródła światła
 
     // Obliczenie współczynnika cienia
-    float shadowFactor = CalculateShadowFactorPCF_2D(FragPosDirLightSpace, dirShadowMap, shadowMapTexelSize, normal, lightDirToSource);
+    float shadowFactor = CalculateDirShadowFactorCSM(FragPos_World, normal, lightDirToSource);
 
     // Składowa Ambient
     vec3 ambient = light.ambient * currentMaterialAmbient;
@@ -240,17 +475,11 @@ vec3 CalculateSpotLightContribution(SpotLight light, vec3 normal, vec3 fragPos,
 
     // Obliczenie współczynnika cienia, jeśli reflektor rzuca cień
     float shadowFactor = 0.0;
-    if (light.castsShadow && light.shadowDataIndex >= 0 && light.shadowDataIndex < MAX_SHADOW_CASTING_SPOT_LIGHTS_FS) {
-        if (spotLightShadowData[light.shadowDataIndex].enabled) {
-             shadowFactor = CalculateShadowFactorPCF_2D(
-                FragPosSpotLightSpace[light.shadowDataIndex], // Użyj odpowiedniego FragPos dla tego reflektora
-                spotLightShadowData[light.shadowDataIndex].shadowMap,
-                spotLightShadowData[light.shadowDataIndex].texelSize,
-                normal,
-                lightToFragDir // Kierunek DO źródła światła
-            );
-        }
+#if SHADOWS_PCF
+    if (light.castsShadow && light.shadowDataIndex >= 0) {
+        shadowFactor = CalculateAtlasShadowFactor(light.shadowDataIndex, fragPos, normal, lightToFragDir); // Kierunek DO źródła światła
     }
+#endif
 
     // Składowa Ambient
     vec3 ambient = light.ambient * currentMaterialAmbient;
@@ -284,11 +513,11 @@ vec3 CalculatePointLightContribution(PointLight light, int lightIndex, vec3 norm
 
     // Obliczenie współczynnika cienia, jeśli światło punktowe rzuca cień
     float shadowFactor = 0.0;
-    if (light.castsShadow && light.shadowDataIndex >= 0 && light.shadowDataIndex < MAX_SHADOW_CASTING_POINT_LIGHTS_FS) {
-        if (pointLightShadowData[light.shadowDataIndex].enabled) {
-            shadowFactor = CalculatePointShadowFactor(fragPos, light, pointLightShadowData[light.shadowDataIndex]);
-        }
+#if SHADOWS_PCF
+    if (light.castsShadow && light.shadowDataIndex >= 0) {
+        shadowFactor = CalculatePointShadowFactor(fragPos, light, normal, lightToFragDir);
     }
+#endif
 
     // Składowa Ambient
     vec3 ambient = light.ambient * currentMaterialAmbient;
@@ -321,34 +550,54 @@ void main() {
     vec3 effectiveSpecular;
     float effectiveShininess = material.shininess; // Połysk zazwyczaj nie pochodzi bezpośrednio z tekstury
 
-    // Kolor Ambient: modulowany przez teksturę diffuse lub bazowy kolor ambient materiału
-    if (material.useDiffuseTexture) {
-        // Moduluj bazowy kolor ambient materiału (z uniformu) przez kolor z tekstury diffuse
-        effectiveAmbient = material.ambient * texture(material.diffuseTexture, TexCoords).rgb;
+    if (MaterialIndex_FS >= 0) {
+        // Materiał z bloku MaterialBlock, tekstury ze stron (bez bindowania tekstur na obiekt)
+        MaterialEntry entry = materials[MaterialIndex_FS];
+        effectiveShininess = entry.ambientShininess.a;
+        effectiveAmbient = entry.ambientShininess.rgb;
+        effectiveDiffuse = entry.diffuse.rgb;
+        effectiveSpecular = entry.specular.rgb;
+        if (entry.textures.x >= 0) {
+            effectiveDiffuse = SampleMaterialPage(entry.textures.x, entry.textures.y, TexCoords).rgb;
+            effectiveAmbient *= effectiveDiffuse;
+        }
+        if (entry.textures.z >= 0) {
+            effectiveSpecular = SampleMaterialPage(entry.textures.z, entry.textures.w, TexCoords).rgb;
+        }
     } else {
-        effectiveAmbient = material.ambient; // Użyj bazowego koloru ambient z uniformu Material
-    }
+        // Kolor Ambient: modulowany przez teksturę diffuse lub bazowy kolor ambient materiału
+        if (USE_DIFFUSE_TEXTURE) {
+            // Moduluj bazowy kolor ambient materiału (z uniformu) przez kolor z tekstury diffuse
+            effectiveAmbient = material.ambient * texture(material.diffuseTexture, TexCoords).rgb;
+        } else {
+            effectiveAmbient = material.ambient; // Użyj bazowego koloru ambient z uniformu Material
+        }
 
-    // Kolor Diffuse: z tekstury diffuse lub bazowy kolor diffuse materiału
-    if (material.useDiffuseTexture) {
-        effectiveDiffuse = texture(material.diffuseTexture, TexCoords).rgb;
-    } else {
-        effectiveDiffuse = material.diffuse; // Użyj bazowego koloru diffuse z uniformu Material
-    }
+        // Kolor Diffuse: z tekstury diffuse lub bazowy kolor diffuse materiału
+        if (USE_DIFFUSE_TEXTURE) {
+            effectiveDiffuse = texture(material.diffuseTexture, TexCoords).rgb;
+        } else {
+            effectiveDiffuse = material.diffuse; // Użyj bazowego koloru diffuse z uniformu Material
+        }
 
-    // Kolor Specular: z tekstury specular lub bazowy kolor specular materiału
-    if (material.useSpecularTexture) {
-        // Zakładamy, że tekstura specular dostarcza pełny kolor RGB dla odbicia
-        effectiveSpecular = texture(material.specularTexture, TexCoords).rgb;
-        // Alternatywnie, jeśli tekstura specular to mapa intensywności (skala szarości):
-        // effectiveSpecular = material.specular * texture(material.specularTexture, TexCoords).r;
-    } else {
-        effectiveSpecular = material.specular; // Użyj bazowego koloru specular z uniformu Material
+        // Kolor Specular: z tekstury specular lub bazowy kolor specular materiału
+        if (USE_SPECULAR_TEXTURE) {
+            // Zakładamy, że tekstura specular dostarcza pełny kolor RGB dla odbicia
+            effectiveSpecular = texture(material.specularTexture, TexCoords).rgb;
+            // Alternatywnie, jeśli tekstura specular to mapa intensywności (skala szarości):
+            // effectiveSpecular = material.specular * texture(material.specularTexture, TexCoords).r;
+        } else {
+            effectiveSpecular = material.specular; // Użyj bazowego koloru specular z uniformu Material
+        }
     }
 
+    // Zabarwienie instancji (dla obiektów rysowanych bez instancjonowania mnożnik wynosi 1.0)
+    effectiveAmbient *= InstanceTint_FS.rgb;
+    effectiveDiffuse *= InstanceTint_FS.rgb;
+
 
     // --- Wybór modelu cieniowania ---
-    if (u_UseFlatShading) {
+    if (USE_FLAT_SHADING) {
         // Tryb płaskiego cieniowania (unlit): użyj tylko efektywnego koloru diffuse (np. koloru z tekstury)
         // Można też użyć VertexColor_FS, jeśli jest przekazywany i pożądany.
         FragColor = vec4(effectiveDiffuse, 1.0);
@@ -357,7 +606,7 @@ void main() {
 
         // Przygotowanie wektorów potrzebnych do obliczeń oświetlenia
         vec3 norm_world = normalize(Normal_World); // Znormalizowany wektor normalny fragmentu
-        vec3 viewDir_world = normalize(viewPos_World - FragPos_World); // Znormalizowany kierunek od fragmentu do kamery
+        vec3 viewDir_world = normalize(cameraPosition - FragPos_World); // Znormalizowany kierunek od fragmentu do kamery
 
         vec3 resultColor = vec3(0.0); // Inicjalizacja wynikowego koloru
 
@@ -365,21 +614,20 @@ void main() {
         resultColor += CalculateDirLightContribution(dirLight, norm_world, viewDir_world,
                                                     effectiveAmbient, effectiveDiffuse, effectiveSpecular, effectiveShininess);
 
-        // Obliczanie wkładu od aktywnych reflektorów
-        for (int i = 0; i < numSpotLights; i++) {
-            // Upewniamy się, że nie wyjdziemy poza zadeklarowany rozmiar tablicy uniformów
-            if (i < MAX_SPOT_LIGHTS_TOTAL_FS) {
-                resultColor += CalculateSpotLightContribution(spotLights[i], norm_world, FragPos_World, viewDir_world,
+        // Obliczanie wkładu od reflektorów i świateł punktowych z listy klastra fragmentu
+        // (tylko światła, których zasięg obejmuje ten klaster - koszt nie rośnie z liczbą świateł w scenie)
+        int cluster = ComputeClusterIndex(FragPos_World);
+        int firstItem = int(texelFetch(u_clusterItems, cluster * 2).r);
+        int itemCount = int(texelFetch(u_clusterItems, cluster * 2 + 1).r);
+        for (int i = 0; i < itemCount; i++) {
+            int lightIndex = int(texelFetch(u_clusterItems, firstItem + i).r);
+            int base = lightIndex * CLUSTER_LIGHT_TEXELS_FS;
+            if (texelFetch(u_clusterLights, base).w > 0.5) {
+                resultColor += CalculateSpotLightContribution(FetchSpotLight(base), norm_world, FragPos_World, viewDir_world,
                                                               effectiveAmbient, effectiveDiffuse, effectiveSpecular, effectiveShininess);
-            }
-        }
-
-        // Obliczanie wkładu od aktywnych świateł punktowych
-        for (int i = 0; i < numPointLights; i++) {
-            // Upewniamy się, że nie wyjdziemy poza zadeklarowany rozmiar tablicy uniformów
-            if (i < MAX_POINT_LIGHTS_FS) {
-                 resultColor += CalculatePointLightContribution(pointLights[i], i, norm_world, FragPos_World, viewDir_world,
-                                                                effectiveAmbient, effectiveDiffuse, effectiveSpecular, effectiveShininess);
+            } else {
+                resultColor += CalculatePointLightContribution(FetchPointLight(base), lightIndex, norm_world, FragPos_World, viewDir_world,
+                                                               effectiveAmbient, effectiveDiffuse, effectiveSpecular, effectiveShininess);
             }
         }
         FragColor = vec4(resultColor, 1.0); // Ustawienie finalnego koloru fragmentu (z domyślną alfa = 1.0)
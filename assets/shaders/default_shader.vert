@@ -1,68 +1,67 @@
 #version 330 core
 
-// Stałe (powinny być zsynchronizowane z C++ oraz Fragment Shaderem)
-// Definiujemy tutaj, aby bylo spójne z FS i komentarzami.
-// W praktyce, jesli te stale sa takie same dla VS i FS, mozna rozwazyc przekazanie
-// ich przez system budowania shaderow lub uzycie wspolnego pliku include (jesli system to wspiera).
-const int MAX_SHADOW_CASTING_SPOT_LIGHTS_VS = 2; // Rozmiar tablic dla cieni reflektorów w VS
-
 // --- Atrybuty wejściowe wierzchołka ---
 layout (location = 0) in vec3 aPos;        // Pozycja wierzchołka (przestrzeń lokalna modelu)
 layout (location = 1) in vec3 aNormal;     // Wektor normalny wierzchołka (przestrzeń lokalna modelu)
 layout (location = 2) in vec2 aTexCoords;  // Współrzędne tekstury
 layout (location = 3) in vec4 aColor;      // Kolor wierzchołka (opcjonalny)
 
+// --- Atrybuty instancji (tylko dla rysowania instancjonowanego, divisor = 1) ---
+// Lokalizacje muszą być zsynchronizowane z InstanceBuffer.h.
+layout (location = 4) in mat4 aInstanceModel; // Macierz modelu instancji (zajmuje lokalizacje 4-7)
+layout (location = 8) in vec4 aInstanceTint;  // Mnożnik koloru materiału dla instancji
+layout (location = 9) in int aInstanceMaterial; // Indeks materiału w MaterialBlock (tylko StaticBatch)
+
 // --- Wyjścia do Fragment Shadera (interpolowane) ---
 out vec3 FragPos_World;            // Pozycja fragmentu w przestrzeni świata
 out vec3 Normal_World;             // Wektor normalny fragmentu w przestrzeni świata
 out vec2 TexCoords;                // Współrzędne tekstury
 out vec4 VertexColor_FS;           // Kolor wierzchołka przekazany do FS
-out vec4 FragPosDirLightSpace;     // Pozycja fragmentu w przestrzeni światła kierunkowego (dla cieni)
+out vec4 InstanceTint_FS;          // Mnożnik koloru materiału (vec4(1.0) poza instancjonowaniem)
+flat out int MaterialIndex_FS;     // Indeks materiału w MaterialBlock (-1 = uniform 'material' w FS)
 
-// Pozycja fragmentu w przestrzeniach świateł reflektorów rzucających cień
-out vec4 FragPosSpotLightSpace[MAX_SHADOW_CASTING_SPOT_LIGHTS_VS];
+// Głębokość musi być identyczna z przebiegiem wstępnym (depth_shader.vert, test GL_LEQUAL).
+invariant gl_Position;
 
-// --- Uniformy (zmienne globalne ustawiane z CPU) ---
-uniform mat4 model;                // Macierz modelu (transformacja lokalna -> świat)
-uniform mat4 view;                 // Macierz widoku (transformacja świat -> widok/kamera)
-uniform mat4 projection;           // Macierz projekcji (transformacja widok -> przestrzeń przycinania)
+// --- Blok stałych klatki (UBO) ---
+// Aktualizowany raz na klatkę przez Renderer, wspólny dla wszystkich obiektów.
+// Punkt wiązania nadawany jest z C++ (FRAME_UBO_BINDING_POINT w UniformBlocks.h).
+layout (std140) uniform FrameConstants {
+    mat4 view;               // Macierz widoku (transformacja świat -> widok/kamera)
+    mat4 projection;         // Macierz projekcji (transformacja widok -> przestrzeń przycinania)
+    mat4 viewProjection;     // projection * view, policzone na CPU
+    vec3 cameraPosition;     // Pozycja kamery w przestrzeni świata
+    float time;              // Czas od uruchomienia aplikacji (sekundy)
+};
 
-// Uniformy dla cieni światła kierunkowego
-uniform mat4 dirLightSpaceMatrix;  // Macierz transformująca do przestrzeni światła kierunkowego
+// --- Uniformy (zmienne globalne ustawiane z CPU) ---
+uniform mat4 model;                // Macierz modelu (transformacja lokalna -> świat) - jedyny uniform per obiekt
+uniform bool u_instanced;          // Flaga: czy macierz modelu pochodzi z atrybutu instancji zamiast z uniformu 'model'
+uniform bool u_instanceMaterial;   // Flaga: czy indeks materiału pochodzi z atrybutu instancji (rysowanie pośrednie StaticBatch)
+uniform int u_materialIndex = -1;  // Indeks materiału w MaterialBlock dla zwykłego rysowania (-1 = uniform 'material')
 
-// Uniformy dla cieni reflektorów
-// Tablica macierzy transformujących do przestrzeni świateł reflektorów rzucających cień
-uniform mat4 spotLightSpaceMatricesVS[MAX_SHADOW_CASTING_SPOT_LIGHTS_VS];
-uniform int numActiveSpotShadowCastersVS; // Liczba aktywnych reflektorów rzucających cień (ile macierzy użyć)
+// Cienie są liczone w FS z FragPos_World: kaskada zależy od głębokości fragmentu,
+// a macierze reflektorów i świateł punktowych pochodzą z bufora widoków atlasu cieni.
 
 void main() {
-    // Transformacja pozycji wierzchołka do przestrzeni przycinania (clip space)
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    // Wybór macierzy modelu: z bufora instancji lub z uniformu (zwykłe rysowanie)
+    mat4 modelMatrix = u_instanced ? aInstanceModel : model;
+    InstanceTint_FS = u_instanced ? aInstanceTint : vec4(1.0);
+    MaterialIndex_FS = u_instanceMaterial ? aInstanceMaterial : u_materialIndex;
 
     // Transformacja pozycji wierzchołka do przestrzeni świata (dla obliczeń oświetlenia w FS)
-    FragPos_World = vec3(model * vec4(aPos, 1.0));
+    vec4 worldPos = modelMatrix * vec4(aPos, 1.0);
+    FragPos_World = vec3(worldPos);
+
+    // Transformacja pozycji wierzchołka do przestrzeni przycinania (clip space)
+    gl_Position = viewProjection * worldPos;
 
     // Transformacja wektora normalnego do przestrzeni świata
     // Używamy macierzy normalnych (transponowana odwrotność części 3x3 macierzy modelu)
     // aby poprawnie obsłużyć niejednorodne skalowanie modelu.
-    Normal_World = normalize(mat3(transpose(inverse(model))) * aNormal);
+    Normal_World = normalize(mat3(transpose(inverse(modelMatrix))) * aNormal);
 
     // Przekazanie współrzędnych tekstury i koloru wierzchołka bez zmian
     TexCoords = aTexCoords;
     VertexColor_FS = aColor;
-
-    // Transformacja pozycji fragmentu do przestrzeni światła kierunkowego
-    FragPosDirLightSpace = dirLightSpaceMatrix * model * vec4(aPos, 1.0);
-
-    // Oblicz pozycje w przestrzeniach świateł dla aktywnych reflektorów rzucających cień
-    // Iterujemy tylko przez aktywne reflektory rzucajace cien, dla ktorych mamy macierze.
-    for (int i = 0; i < numActiveSpotShadowCastersVS; ++i) {
-        // Upewniamy się, że nie wychodzimy poza zadeklarowany rozmiar tablicy
-        // (chociaż numActiveSpotShadowCastersVS powinno być <= MAX_SHADOW_CASTING_SPOT_LIGHTS_VS)
-        if (i < MAX_SHADOW_CASTING_SPOT_LIGHTS_VS) {
-            FragPosSpotLightSpace[i] = spotLightSpaceMatricesVS[i] * model * vec4(aPos, 1.0);
-        }
-    }
-    // Dla nieużywanych slotów FragPosSpotLightSpace nie musimy nic robić,
-    // ponieważ Fragment Shader powinien iterować tylko do `numActiveSpotShadowCastersFS` (lub odpowiednika).
 }
@@ -0,0 +1,22 @@
+#version 330 core
+
+// --- Atrybuty wejściowe wierzchołka ---
+layout (location = 0) in vec3 aPos; // Pozycja wierzchołka w przestrzeni lokalnej modelu
+layout (location = 4) in mat4 aInstanceModel; // Macierz modelu instancji (lokalizacje 4-7, tylko przy instancjonowaniu)
+
+// --- Uniformy ---
+uniform mat4 model;       // Macierz modelu (transformacja z przestrzeni lokalnej do przestrzeni świata)
+uniform bool u_instanced; // Flaga: czy macierz modelu pochodzi z atrybutu instancji
+
+// --- Wyjście do Geometry Shadera ---
+// Pozycja wierzchołka w przestrzeni świata. Transformację do przestrzeni światła
+// wykonuje geometry shader, osobno dla każdej ściany mapy sześciennej.
+out vec3 WorldPos_GS;
+
+void main()
+{
+    mat4 modelMatrix = u_instanced ? aInstanceModel : model;
+    vec4 worldPos = modelMatrix * vec4(aPos, 1.0);
+    WorldPos_GS = vec3(worldPos);
+    gl_Position = worldPos;
+}
@@ -2,26 +2,28 @@
 
 // --- Atrybuty wejściowe wierzchołka ---
 layout (location = 0) in vec3 aPos; // Pozycja wierzchołka w przestrzeni lokalnej modelu
+layout (location = 4) in mat4 aInstanceModel; // Macierz modelu instancji (lokalizacje 4-7, tylko przy instancjonowaniu)
 
 // --- Uniformy ---
 uniform mat4 model;            // Macierz modelu (transformacja z przestrzeni lokalnej do przestrzeni świata)
+uniform bool u_instanced;      // Flaga: czy macierz modelu pochodzi z atrybutu instancji
 uniform mat4 lightSpaceMatrix; // Macierz transformująca do przestrzeni światła (zazwyczaj lightView * lightProjection)
 
-// --- Wyjście do Fragment Shadera ---
-// Pozycja fragmentu w przestrzeni świata.
-// Potrzebna w FS do obliczenia liniowej głębokości dla map sześciennych (PointLight).
-out vec3 FragPos_World_DS;
+// Przebieg wstępny głębokości sceny używa tego shadera z lightSpaceMatrix = viewProjection kamery.
+// Główny przebieg testuje głębokość z GL_LEQUAL, więc obie pozycje muszą wyjść bit w bit identyczne
+// (to samo wyrażenie worldPos i mnożenie jak w default_shader.vert).
+invariant gl_Position;
 
 void main()
 {
     // Krok 1: Transformacja pozycji wierzchołka do przestrzeni świata.
-    // Ta wartość jest interpolowana i przekazywana do fragment shadera.
-    FragPos_World_DS = vec3(model * vec4(aPos, 1.0));
+    mat4 modelMatrix = u_instanced ? aInstanceModel : model;
+    vec4 worldPos = modelMatrix * vec4(aPos, 1.0);
 
     // Krok 2: Transformacja pozycji wierzchołka do przestrzeni przycinania (clip space) z perspektywy światła.
     // Wynikowa pozycja (gl_Position) jest używana przez OpenGL do testu głębokości
     // i rasteryzacji, a jej wartość .z (po transformacji perspektywicznej i normalizacji)
     // jest zapisywana do bufora głębi (depth map).
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+    gl_Position = lightSpaceMatrix * worldPos;
 }
 
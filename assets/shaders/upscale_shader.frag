@@ -0,0 +1,38 @@
+#version 330 core
+
+// --- Skalowanie obrazu sceny z dynamicznej rozdzielczości do rozdzielczości okna ---
+// Filtr dwuliniowy (sprzętowy) z opcjonalnym wyostrzaniem: od próbki środkowej
+// odejmowana jest średnia sąsiadów odległych o jeden teksel źródła (maska nieostra),
+// a wynik jest ograniczany do zakresu sąsiedztwa, co zapobiega jasnym obwódkom na krawędziach.
+
+// --- Wyjście shadera ---
+out vec4 FragColor;
+
+// --- Wejście z Vertex Shadera (interpolowane) ---
+in vec2 TexCoords;
+
+// --- Uniformy ---
+uniform sampler2D u_scene;  // Kolor sceny (tekstura przydzielona na maksymalną skalę)
+uniform vec4 u_sourceRect;  // xy - ułamek tekstury zajęty przez scenę, zw - rozmiar teksela
+uniform float u_sharpness;  // 0 - sam filtr dwuliniowy, 1 - pełne wyostrzanie
+
+void main() {
+    // Obszar sceny to lewy dolny róg tekstury; pół teksela zapasu odcina dane spoza obszaru
+    vec2 maxUV = u_sourceRect.xy - 0.5 * u_sourceRect.zw;
+    vec2 uv = min(TexCoords * u_sourceRect.xy, maxUV);
+    vec3 center = texture(u_scene, uv).rgb;
+
+    if (u_sharpness > 0.0) {
+        vec3 left = texture(u_scene, clamp(uv - vec2(u_sourceRect.z, 0.0), vec2(0.0), maxUV)).rgb;
+        vec3 right = texture(u_scene, clamp(uv + vec2(u_sourceRect.z, 0.0), vec2(0.0), maxUV)).rgb;
+        vec3 down = texture(u_scene, clamp(uv - vec2(0.0, u_sourceRect.w), vec2(0.0), maxUV)).rgb;
+        vec3 up = texture(u_scene, clamp(uv + vec2(0.0, u_sourceRect.w), vec2(0.0), maxUV)).rgb;
+
+        vec3 neighbourhoodMin = min(center, min(min(left, right), min(down, up)));
+        vec3 neighbourhoodMax = max(center, max(max(left, right), max(down, up)));
+        vec3 blurred = 0.25 * (left + right + down + up);
+        center = clamp(center + u_sharpness * (center - blurred), neighbourhoodMin, neighbourhoodMax);
+    }
+
+    FragColor = vec4(center, 1.0);
+}
@@ -0,0 +1,15 @@
+#version 330 core
+
+// --- Trójkąt pełnoekranowy bez bufora wierzchołków ---
+// Trzy wierzchołki generowane z gl_VertexID pokrywają cały ekran jednym trójkątem
+// (bez szwu na przekątnej, jak przy dwóch trójkątach czworokąta).
+
+// --- Wyjście do Fragment Shadera (interpolowane) ---
+out vec2 TexCoords; // Współrzędne w obrazie sceny: (0,0) - (1,1) na obszarze okna
+
+void main() {
+    // Wierzchołki: (-1,-1), (3,-1), (-1,3) w NDC
+    vec2 position = vec2(float((gl_VertexID & 1) << 2) - 1.0, float((gl_VertexID & 2) << 1) - 1.0);
+    TexCoords = position * 0.5 + 0.5;
+    gl_Position = vec4(position, 0.0, 1.0);
+}